@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Workload generator for advcalc2ir benchmarks
+ * Usage: gen <mixed|flat|nested|funcs|vars|overflow> <line count> <seed>
+ * Writes a .adv program to stdout. Output only depends on the arguments.
+ *
+ * Generated lines are kept under MAX_LINE chars since the compiler reads 256 chars per line.
+ * VAR_COUNT variables are declared first, 100 for most workloads and VAR_LIMIT - 96 for vars, which stays
+ * under the size of the compiler's lookup table. VAR_LIMIT is passed by the makefile from main.c.
+ * overflow only declares VAR_LIMIT + 1 variables and ignores line count, the compiler must reject its last line.
+ * Divisors are non-zero literals so generated programs can also be run.
+ * */
+#define MAX_LINE 200
+#ifndef VAR_LIMIT
+#error "VAR_LIMIT must be defined, build with make bench/gen"
+#endif
+
+int VAR_COUNT = 100;
+unsigned long long SEED;
+char LINE[MAX_LINE + 64];
+int LEN;
+
+/*
+ * Return next pseudo random number in [0, n)
+ * */
+int rnd(int n) {
+    SEED = SEED * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (int) ((SEED >> 33) % n);
+}
+
+/*
+ * Append given string to the current line
+ * */
+void put(char *str) {
+    strcpy(LINE + LEN, str);
+    LEN += strlen(str);
+}
+
+/*
+ * Append a variable name, names are "v" followed by three letters so they never match a keyword
+ * */
+void put_var(int idx) {
+    char name[5] = {'v', 'a' + idx / 676, 'a' + idx / 26 % 26, 'a' + idx % 26, '\0'};
+    put(name);
+}
+
+/*
+ * Append a variable or a small integer
+ * */
+void put_operand() {
+    char num[16];
+    if (rnd(2)) {
+        put_var(rnd(VAR_COUNT));
+    } else {
+        sprintf(num, "%d", 1 + rnd(99));
+        put(num);
+    }
+}
+
+/*
+ * Append a random expression of given depth
+ * Binary operators and functions are chosen uniformly, depth 0 is a single operand
+ * */
+void put_exp(int depth) {
+    char *oprs[] = {" + ", " - ", " * ", " / ", " % ", " & ", " | "};
+    char *funcs[] = {"xor(", "ls(", "rs(", "lr(", "rr("};
+    if (depth == 0 || LEN > MAX_LINE / 2) {
+        put_operand();
+        return;
+    }
+    int kind = rnd(4);
+    if (kind == 0) {
+        put("(");
+        put_exp(depth - 1);
+        put(")");
+    } else if (kind == 1) {
+        put(funcs[rnd(5)]);
+        put_exp(depth - 1);
+        put(", ");
+        put_exp(depth - 1);
+        put(")");
+    } else if (kind == 2) {
+        put("not(");
+        put_exp(depth - 1);
+        put(")");
+    } else {
+        int opr = rnd(7);
+        put_exp(depth - 1);
+        put(oprs[opr]);
+        if (opr == 3 || opr == 4) { //Division and modulus by a positive literal never trap at runtime
+            char num[16];
+            sprintf(num, "%d", 1 + rnd(99));
+            put(num);
+        } else {
+            put_exp(depth - 1);
+        }
+    }
+}
+
+/*
+ * Fill LINE with one statement of given workload kind
+ * Lines of the mixed workload are assignments or prints with equal probability
+ * */
+void gen_line(char *kind) {
+    LEN = 0;
+    if (strcmp(kind, "mixed") == 0) {
+        if (rnd(2)) {
+            put_var(rnd(VAR_COUNT));
+            put(" = ");
+        }
+        put_exp(1 + rnd(3));
+    } else if (strcmp(kind, "flat") == 0) {
+        char *oprs[] = {" + ", " - ", " * ", " & ", " | "};
+        put_var(rnd(VAR_COUNT));
+        put(" = ");
+        put_operand();
+        while (LEN < MAX_LINE - 8) {
+            put(oprs[rnd(5)]);
+            put_operand();
+        }
+    } else if (strcmp(kind, "nested") == 0) {
+        int depth = 0;
+        put_var(rnd(VAR_COUNT));
+        put(" = ");
+        while (LEN + 2 * depth < MAX_LINE - 8) {
+            put("(");
+            depth++;
+        }
+        put_operand();
+        while (depth > 0) {
+            if (LEN + depth + 5 < MAX_LINE) { //Add operators while the remaining parentheses still fit
+                put(" + 1");
+            }
+            put(")");
+            depth--;
+        }
+    } else if (strcmp(kind, "funcs") == 0) {
+        char *funcs[] = {"xor(", "lr(", "rr("};
+        int depth = 0;
+        put_var(rnd(VAR_COUNT));
+        put(" = ");
+        while (LEN + 7 * depth < MAX_LINE - 10) { //Each function needs up to 7 more chars to be closed
+            put(funcs[rnd(3)]);
+            depth++;
+        }
+        put_operand();
+        while (depth > 0) {
+            put(", ");
+            put_operand();
+            put(")");
+            depth--;
+        }
+    } else {
+        char *oprs[] = {" + ", " - ", " & ", " | "};
+        put_var(rnd(VAR_COUNT));
+        put(" = ");
+        put_var(rnd(VAR_COUNT));
+        while (LEN < MAX_LINE - 10) {
+            put(oprs[rnd(4)]);
+            put_var(rnd(VAR_COUNT));
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 4) {
+        printf("Usage: %s <mixed|flat|nested|funcs|vars|overflow> <line count> <seed>\n", argv[0]);
+        return 1;
+    }
+    char *kind = argv[1];
+    long lines = atol(argv[2]);
+    SEED = strtoull(argv[3], NULL, 10);
+    if (strcmp(kind, "vars") == 0) {
+        VAR_COUNT = VAR_LIMIT - 96;
+    } else if (strcmp(kind, "overflow") == 0) {
+        VAR_COUNT = VAR_LIMIT + 1;
+        lines = 0;
+    }
+
+    //Declare every variable first so later lines never use an undefined one
+    for (int i = 0; i < VAR_COUNT; i++) {
+        LEN = 0;
+        put_var(i);
+        put(" = ");
+        char num[16];
+        sprintf(num, "%d", 1 + i);
+        put(num);
+        printf("%s\n", LINE);
+    }
+    for (long i = VAR_COUNT; i < lines; i++) {
+        gen_line(kind);
+        printf("%s\n", LINE);
+    }
+    return 0;
+}
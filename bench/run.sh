@@ -0,0 +1,78 @@
+#!/bin/sh
+# Benchmark harness for advcalc2ir
+# Usage: bench/run.sh [lines] [seed]
+# Generates every workload with bench/gen, compiles it with advcalc2ir --stats and prints
+# throughput, per phase time and peak RSS. It also checks that a program declaring more
+# variables than the lookup table holds is rejected instead of crashing the compiler.
+# Baselines are kept per host as "<host> <workload> <lines/s>" lines in BENCH_BASELINE,
+# bench/baseline.txt by default, which is not tracked since the numbers only hold for one host.
+# A workload whose lines/s drops more than BENCH_TOLERANCE percent below this host's
+# baseline is reported and makes the script fail. With BENCH_UPDATE=1 this host's
+# baseline is replaced by the measured lines/s instead. A host without a baseline fails
+# unless BENCH_UPDATE=1 records one or BENCH_NO_BASELINE=1 explicitly skips the comparison.
+
+LINES=${1:-100000}
+SEED=${2:-1}
+TOLERANCE=${BENCH_TOLERANCE:-20}
+DIR=$(dirname "$0")
+COMPILER=$DIR/../advcalc2ir
+BASELINE=${BENCH_BASELINE:-$DIR/baseline.txt}
+HOST=$(uname -n)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+status=0
+if [ "$BENCH_UPDATE" = 1 ]; then
+    : > "$WORK/update"
+elif ! grep -q "^$HOST " "$BASELINE" 2>/dev/null; then
+    if [ "$BENCH_NO_BASELINE" = 1 ]; then
+        echo "No baseline for $HOST, comparison skipped"
+    else
+        echo "FAILED: no baseline for $HOST, run with BENCH_UPDATE=1 to record one or BENCH_NO_BASELINE=1 to skip"
+        status=1
+    fi
+fi
+
+"$DIR/gen" overflow 0 "$SEED" > "$WORK/overflow.adv"
+"$COMPILER" "$WORK/overflow.adv" > "$WORK/overflow.out"
+overflow_rc=$?
+overflow_line=$(wc -l < "$WORK/overflow.adv")
+if [ $overflow_rc -ne 1 ] || ! grep -q "^Error on line $overflow_line!$" "$WORK/overflow.out"; then
+    echo "FAILED: variable $overflow_line was not rejected"
+    status=1
+fi
+
+printf "%-8s %10s %12s %9s %9s %9s %9s %10s\n" workload lines/s tokens/s lexer syntax reformat calculate "rss(kB)"
+for kind in mixed flat nested funcs vars; do
+    "$DIR/gen" $kind "$LINES" "$SEED" > "$WORK/$kind.adv"
+    rate=
+    if "$COMPILER" --stats "$WORK/$kind.adv" > "$WORK/$kind.stats"; then
+        rate=$(awk '/^lines:/ { gsub(/\(/, "", $3); print $3 }' "$WORK/$kind.stats")
+    fi
+    awk -v kind=$kind '
+        /^lines:/ { gsub(/\(/, "", $3); lines = $3 }
+        /^tokens:/ { gsub(/\(/, "", $3); tokens = $3 }
+        /^phase/ { time[$2] = $3 }
+        /^peak rss:/ { rss = $3 }
+        END { printf "%-8s %10s %12s %9s %9s %9s %9s %10s\n", kind, lines, tokens,
+              time["lexer:"], time["syntax_checker:"], time["reformat_token_list:"], time["calculate:"], rss }
+    ' "$WORK/$kind.stats"
+    if [ -z "$rate" ]; then
+        echo "FAILED: $kind did not compile"
+        status=1
+    elif [ "$BENCH_UPDATE" = 1 ]; then
+        echo "$HOST $kind $rate" >> "$WORK/update"
+    else
+        base=$(awk -v host="$HOST" -v kind=$kind '$1 == host && $2 == kind { print $3 }' "$BASELINE" 2>/dev/null)
+        if [ -n "$base" ] && [ "$rate" -lt $((base * (100 - TOLERANCE) / 100)) ]; then
+            echo "REGRESSION: $kind $rate lines/s, baseline $base lines/s"
+            status=1
+        fi
+    fi
+done
+#This host's baseline is only replaced when every workload compiled
+if [ "$BENCH_UPDATE" = 1 ] && [ $status -eq 0 ]; then
+    touch "$BASELINE"
+    awk -v host="$HOST" '$1 != host' "$BASELINE" | cat - "$WORK/update" > "$WORK/baseline" && cp "$WORK/baseline" "$BASELINE"
+fi
+exit $status
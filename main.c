@@ -2,6 +2,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#define VAR_LIMIT 4096 //Size of the variable lookup table, bench/gen reads it from here
 
 
 typedef enum {
@@ -45,16 +49,176 @@ char SIGNS[] = {'=', '+', '-', '*', '/', '%', '&', '|', '(', ')', ','};
  * VAR_KEYS holds variable names for the lookup table.
  * VARS holds variable values, and they share indices with VAR_KEYS
  * VAR_IDX holds next free index of the lookup table, must be updated when new var added
+ * The lookup table holds VAR_LIMIT variables, assigning a new variable to a full table is an error
  * REG_IDX holds next free index of the LLVM register
  * LINE_IDX holds the current line index
  * */
-char *VAR_KEYS[128];
-long long VARS[128];
+char *VAR_KEYS[VAR_LIMIT];
+long long VARS[VAR_LIMIT];
 int VAR_IDX = 0;
 int REG_IDX = 1;
 int LINE_IDX = 1;
 FILE *op;
 
+/*
+ * LINE_TOKENS holds every token allocated by lexer for the current line
+ * calculate() unlinks tokens from the list while reducing it, so they are freed from here instead of walking the list
+ * LINE_TOKEN_IDX holds next free index, a line can not have more tokens than chars
+ * */
+struct token *LINE_TOKENS[256 + 1];
+int LINE_TOKEN_IDX = 0;
+
+/*
+ * STATISTICS
+ * STATS_ON is set by --stats, TRACE_FP is opened by --trace=<file>
+ * Phases are timed only when one of them is enabled, otherwise phase_start() and phase_end() return immediately
+ * PHASE_TIME holds total wall time of each phase in nanoseconds, shares indices with PHASE_NAMES
+ * IR is written while lowering, so loads are counted in reformat_token_list and all other per-statement
+ * instructions (including store, printf and profile calls) in calculate. header_close only covers the module
+ * header and the final ret and fclose
+ * OPCODE_COUNT holds number of emitted instructions, shares indices with OPCODES
+ * PROFILE_ON is set by --profile, PROFILE_SLOTS is the length of the generated cycle counter array, one slot per line
+ * Trace spans are aggregated over TRACE_CHUNK lines, set by --trace-chunk=<lines>
+ * CHUNK_TIME holds time of each phase in the current chunk, CHUNK_START is 0 until a phase of the chunk is timed
+ * TRACE_EVENTS holds number of written trace events, events after the first are preceded by a comma
+ * TOKEN_COUNT, ALLOC_COUNT and ALLOC_BYTES are counted unconditionally since they are single increments
+ * */
+typedef enum {
+    P_LEXER,
+    P_SYNTAX,
+    P_REFORMAT,
+    P_CALCULATE,
+    P_HEADER_CLOSE,
+} phase_type;
+
+char *PHASE_NAMES[] = {"lexer", "syntax_checker", "reformat_token_list", "calculate", "header_close"};
+char *OPCODES[] = {"add", "sub", "mul", "sdiv", "srem", "and", "or", "xor", "shl", "ashr", "lshr",
+                   "load", "store", "alloca", "call"};
+long long PHASE_TIME[5];
+long long OPCODE_COUNT[15];
+long long TOKEN_COUNT = 0;
+long long ALLOC_COUNT = 0;
+long long ALLOC_BYTES = 0;
+long long START_TIME = 0;
+int STATS_ON = 0;
+int PROFILE_ON = 0;
+int PROFILE_SLOTS = 0;
+FILE *TRACE_FP = NULL;
+long long TRACE_EVENTS = 0;
+int TRACE_CHUNK = 1000;
+long long CHUNK_TIME[5];
+long long CHUNK_START = 0;
+int CHUNK_FIRST_LINE = 0;
+
+/*
+ * Return monotonic clock time in nanoseconds
+ * */
+long long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+ * Return start time of a phase, 0 if statistics and tracing are disabled
+ * */
+long long phase_start() {
+    if (!STATS_ON && TRACE_FP == NULL) {
+        return 0;
+    }
+    return now_ns();
+}
+
+/*
+ * Write one Chrome trace-event span, timestamps are converted to microseconds since start of compilation
+ * */
+void trace_event(char *name, long long start, long long duration, int first_line, int last_line) {
+    fprintf(TRACE_FP, "%s{\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": 1, "
+                      "\"args\": {\"first_line\": %d, \"last_line\": %d}}",
+            TRACE_EVENTS++ == 0 ? "" : ",\n", name, (start - START_TIME) / 1000.0, duration / 1000.0,
+            first_line, last_line);
+}
+
+/*
+ * Write trace events of the current chunk and start a new one
+ * A "chunk" span covers the wall time of the chunk, phase spans are laid out one after another inside it
+ * with the total time spent in each phase, since phases of different lines interleave
+ * */
+void trace_flush() {
+    if (CHUNK_START == 0) {
+        return;
+    }
+    int last_line = LINE_IDX - 1; //Chunk opened by header_close after the last line must not report a line past the end
+    int first_line = (CHUNK_FIRST_LINE < last_line)? CHUNK_FIRST_LINE: last_line;
+    long long start = CHUNK_START;
+    trace_event("chunk", CHUNK_START, now_ns() - CHUNK_START, first_line, last_line);
+    for (int i = 0; i < 5; i++) {
+        if (CHUNK_TIME[i] != 0) {
+            trace_event(PHASE_NAMES[i], start, CHUNK_TIME[i], first_line, last_line);
+            start += CHUNK_TIME[i];
+            CHUNK_TIME[i] = 0;
+        }
+    }
+    CHUNK_START = 0;
+}
+
+/*
+ * Add elapsed time since start to the given phase and to the current trace chunk
+ * */
+void phase_end(phase_type phase, long long start) {
+    if (!STATS_ON && TRACE_FP == NULL) {
+        return;
+    }
+    long long end = now_ns();
+    PHASE_TIME[phase] += end - start;
+    if (TRACE_FP != NULL) {
+        if (CHUNK_START == 0) {
+            CHUNK_START = start;
+            CHUNK_FIRST_LINE = LINE_IDX;
+        }
+        CHUNK_TIME[phase] += end - start;
+    }
+}
+
+/*
+ * Count an emitted instruction of given opcode
+ * */
+void count_opcode(char *opcode) {
+    if (!STATS_ON) {
+        return;
+    }
+    for (int i = 0; i < 15; i++) { //There are 15 opcodes
+        if (strcmp(opcode, OPCODES[i]) == 0) {
+            OPCODE_COUNT[i]++;
+            return;
+        }
+    }
+}
+
+/*
+ * Print collected statistics to stdout
+ * */
+void print_stats() {
+    double total = (now_ns() - START_TIME) / 1e9;
+    int lines = LINE_IDX - 1;
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("total: %.6f s\n", total);
+    for (int i = 0; i < 5; i++) {
+        printf("phase %s: %.6f s\n", PHASE_NAMES[i], PHASE_TIME[i] / 1e9);
+    }
+    printf("lines: %d (%.0f lines/s)\n", lines, total > 0 ? lines / total : 0);
+    printf("tokens: %lld (%.0f tokens/s)\n", TOKEN_COUNT, total > 0 ? TOKEN_COUNT / total : 0);
+    printf("allocations: %lld (%lld bytes)\n", ALLOC_COUNT, ALLOC_BYTES);
+    printf("peak rss: %ld kB\n", usage.ru_maxrss);
+    for (int i = 0; i < 15; i++) {
+        if (OPCODE_COUNT[i] != 0) {
+            printf("opcode %s: %lld\n", OPCODES[i], OPCODE_COUNT[i]);
+        }
+    }
+}
+
 /*
  * Check whether given char is a valid sign
  * Return 1 on sign, else 0
@@ -196,7 +360,15 @@ int lexer(char *p, int length, struct token **head, struct token **tail, struct
     int idx = 0;
     struct token *prev_token;
     for (int i = 0; i < length; i++) {
+        if (isspace(*p) && *p != '\n') { //Skip spaces before allocating a token for them
+            p += 1;
+            continue;
+        }
         struct token *token = malloc(sizeof(struct token));
+        LINE_TOKENS[LINE_TOKEN_IDX++] = token;
+        ALLOC_COUNT++;
+        ALLOC_BYTES += sizeof(struct token);
+        TOKEN_COUNT++;
         if (*p == '\n') {
             (*token) = eol_parser();
             (*tail) = token;
@@ -209,9 +381,6 @@ int lexer(char *p, int length, struct token **head, struct token **tail, struct
                 (*tail)->prev = prev_token;
             }
             break;
-        } else if (isspace(*p)) {
-            p += 1;
-            continue;
         } else if (isalpha(*p)) {
             (*token) = func_and_var_parser(&p);
         } else if (isdigit(*p)) {
@@ -298,7 +467,8 @@ int exp_syntax_checker(struct token *head) {
             } else if (type == OPEN_P) {
                 p_count++;
                 if (next_type == VAR || next_type == INT || next_type == OPEN_P || next_type == LS
-                    || next_type == RS || next_type == LR || next_type == RR || next_type == NOT) {
+                    || next_type == B_XOR || next_type == RS || next_type == LR || next_type == RR
+                    || next_type == NOT) {
                     iter = iter->next;
                     continue;
                 } else {
@@ -447,6 +617,7 @@ int reformat_token_list(struct token **head) {
                     sprintf(reg_name, "%%reg%d",REG_IDX); //Save register name for further operations
                     strcpy(iter->register_name, reg_name);
                     fprintf(op,"\t%s = load i32, i32* %%%s\n", reg_name, VAR_KEYS[i]);
+                    count_opcode("load");
                     REG_IDX++;
                     break;
                 }
@@ -485,60 +656,70 @@ void calculate_opr(struct token *opr, token_type type) {
             sprintf(new_register_name, "%%reg%d", REG_IDX);
             REG_IDX++;
             fprintf(op,"\t%s = mul i32 %s, %s\n", new_register_name, left_register_name, right_register_name);
+            count_opcode("mul");
             break;
 
         case DIV:
             sprintf(new_register_name, "%%reg%d", REG_IDX);
             REG_IDX++;
             fprintf(op,"\t%s = sdiv i32 %s, %s\n", new_register_name, left_register_name, right_register_name);
+            count_opcode("sdiv");
             break;
 
         case MOD:
             sprintf(new_register_name, "%%reg%d", REG_IDX);
             REG_IDX++;
             fprintf(op,"\t%s = srem i32 %s, %s\n", new_register_name, left_register_name, right_register_name);
+            count_opcode("srem");
             break;
 
         case SUM:
             sprintf(new_register_name, "%%reg%d", REG_IDX);
             REG_IDX++;
             fprintf(op,"\t%s = add i32 %s, %s\n", new_register_name, left_register_name, right_register_name);
+            count_opcode("add");
             break;
 
         case MINUS:
             sprintf(new_register_name, "%%reg%d", REG_IDX);
             REG_IDX++;
             fprintf(op,"\t%s = sub i32 %s, %s\n", new_register_name, left_register_name, right_register_name);
+            count_opcode("sub");
             break;
 
         case B_AND:
             sprintf(new_register_name, "%%reg%d", REG_IDX);
             REG_IDX++;
             fprintf(op,"\t%s = and i32 %s, %s\n", new_register_name, left_register_name, right_register_name);
+            count_opcode("and");
             break;
 
         case B_OR:
             sprintf(new_register_name, "%%reg%d", REG_IDX);
             REG_IDX++;
             fprintf(op, "\t%s = or i32 %s, %s\n", new_register_name, left_register_name, right_register_name);
+            count_opcode("or");
             break;
 
         case B_XOR:
             sprintf(new_register_name, "%%reg%d", REG_IDX);
             REG_IDX++;
             fprintf(op, "\t%s = xor i32 %s, %s\n", new_register_name, left_register_name, right_register_name);
+            count_opcode("xor");
             break;
 
         case LS:
             sprintf(new_register_name, "%%reg%d", REG_IDX);
             REG_IDX++;
             fprintf(op, "\t%s = shl i32 %s, %s\n", new_register_name, left_register_name, right_register_name);
+            count_opcode("shl");
             break;
 
         case RS:
             sprintf(new_register_name, "%%reg%d", REG_IDX);
             REG_IDX++;
             fprintf(op,"\t%s = ashr i32 %s, %s\n", new_register_name, left_register_name, right_register_name);
+            count_opcode("ashr");
             break;
 
         case LR:
@@ -546,17 +727,21 @@ void calculate_opr(struct token *opr, token_type type) {
             sprintf(new_register_nameR, "%%reg%d", REG_IDX);
             REG_IDX++;
             fprintf(op, "\t%s = shl i32 %s, %s\n", new_register_nameR, left_register_name, right_register_name);
+            count_opcode("shl");
             char new_register_name2[16];
             sprintf(new_register_name2, "%%reg%d", REG_IDX);
             REG_IDX++;
             fprintf(op,"\t%s = sub i32 32, %s\n", new_register_name2, right_register_name);
+            count_opcode("sub");
             char new_register_name3[16];
             sprintf(new_register_name3, "%%reg%d", REG_IDX);
             REG_IDX++;
             fprintf(op,"\t%s = lshr i32 %s, %s\n", new_register_name3, left_register_name, new_register_name2);
+            count_opcode("lshr");
             sprintf(new_register_name, "%%reg%d", REG_IDX);
             REG_IDX++;
             fprintf(op, "\t%s = or i32 %s, %s\n", new_register_name, new_register_nameR, new_register_name3);
+            count_opcode("or");
             break;
 
         case RR:
@@ -564,17 +749,21 @@ void calculate_opr(struct token *opr, token_type type) {
             sprintf(new_register_nameR, "%%reg%d", REG_IDX);
             REG_IDX++;
             fprintf(op, "\t%s = lshr i32 %s, %s\n", new_register_nameR, left_register_name, right_register_name);
+            count_opcode("lshr");
             char new_register_name5[16];
             sprintf(new_register_name5, "%%reg%d", REG_IDX);
             REG_IDX++;
             fprintf(op,"\t%s = sub i32 32, %s\n", new_register_name5, right_register_name);
+            count_opcode("sub");
             char new_register_name6[16];
             sprintf(new_register_name6, "%%reg%d", REG_IDX);
             REG_IDX++;
             fprintf(op,"\t%s = shl i32 %s, %s\n", new_register_name6, left_register_name, new_register_name5);
+            count_opcode("shl");
             sprintf(new_register_name, "%%reg%d", REG_IDX);
             REG_IDX++;
             fprintf(op, "\t%s = or i32 %s, %s\n", new_register_name, new_register_nameR, new_register_name6);
+            count_opcode("or");
             break;
 
         default:
@@ -681,6 +870,7 @@ void calculate(struct token *head) {
             sprintf(new_register_name, "%%reg%d", REG_IDX);
             REG_IDX++;
             fprintf(op,"\t%s = xor i32 -1, %s\n", new_register_name, register_name);
+            count_opcode("xor");
             strcpy(head->register_name, new_register_name);
             if (head->prev->prev->prev == NULL) {
                 head->prev->prev = NULL;
@@ -700,6 +890,63 @@ void calculate(struct token *head) {
 
 }
 
+/*
+ * Add cycles elapsed since the previous mark to the slot of the current line when profiling
+ * Statements run one after another, so the previous mark is the start of this statement
+ * Counter reads are done in a helper function so main does not keep a value per statement alive
+ * */
+void profile_mark() {
+    if (!PROFILE_ON) {
+        return;
+    }
+    fprintf(op, "\tcall void @profile.mark(i32 %d)\n", LINE_IDX);
+    count_opcode("call");
+}
+
+/*
+ * Write the cycle counter array, the helper that updates it and the function that reports it at exit
+ * Slots are indexed by line number, slots of lines without statements stay 0 and are not reported
+ * Slot 0 receives the first mark at the start of main and is not reported
+ * */
+void profile_header() {
+    fprintf(op,"@profile.str = constant [22 x i8] c\"line %%d: %%lld cycles\\0A\\00\"\n");
+    fprintf(op,"@profile.cycles = global [%d x i64] zeroinitializer\n", PROFILE_SLOTS);
+    fprintf(op,"@profile.last = global i64 0\n");
+    fprintf(op,"declare i64 @llvm.readcyclecounter()\n\n");
+
+    fprintf(op,"define void @profile.mark(i32 %%line) {\n");
+    fprintf(op,"\t%%end = call i64 @llvm.readcyclecounter()\n");
+    fprintf(op,"\t%%last = load i64, i64* @profile.last\n");
+    fprintf(op,"\tstore i64 %%end, i64* @profile.last\n");
+    fprintf(op,"\t%%cycles = sub i64 %%end, %%last\n");
+    fprintf(op,"\t%%slot = getelementptr [%d x i64], [%d x i64]* @profile.cycles, i32 0, i32 %%line\n",
+            PROFILE_SLOTS, PROFILE_SLOTS);
+    fprintf(op,"\t%%total = load i64, i64* %%slot\n");
+    fprintf(op,"\t%%sum = add i64 %%total, %%cycles\n");
+    fprintf(op,"\tstore i64 %%sum, i64* %%slot\n");
+    fprintf(op,"\tret void\n}\n\n");
+
+    fprintf(op,"define void @profile.report() {\n");
+    fprintf(op,"entry:\n\tbr label %%loop\n");
+    fprintf(op,"loop:\n");
+    fprintf(op,"\t%%line = phi i32 [1, %%entry], [%%next, %%next_line]\n");
+    fprintf(op,"\t%%done = icmp sge i32 %%line, %d\n", PROFILE_SLOTS);
+    fprintf(op,"\tbr i1 %%done, label %%exit, label %%check\n");
+    fprintf(op,"check:\n");
+    fprintf(op,"\t%%slot = getelementptr [%d x i64], [%d x i64]* @profile.cycles, i32 0, i32 %%line\n",
+            PROFILE_SLOTS, PROFILE_SLOTS);
+    fprintf(op,"\t%%cycles = load i64, i64* %%slot\n");
+    fprintf(op,"\t%%used = icmp ne i64 %%cycles, 0\n");
+    fprintf(op,"\tbr i1 %%used, label %%print, label %%next_line\n");
+    fprintf(op,"print:\n");
+    fprintf(op,"\tcall i32 (i8*, ...) @printf(i8* getelementptr ([22 x i8], [22 x i8]* @profile.str, i32 0, i32 0), i32 %%line, i64 %%cycles)\n");
+    fprintf(op,"\tbr label %%next_line\n");
+    fprintf(op,"next_line:\n");
+    fprintf(op,"\t%%next = add i32 %%line, 1\n");
+    fprintf(op,"\tbr label %%loop\n");
+    fprintf(op,"exit:\n\tret void\n}\n");
+}
+
 /*
  * Print tokenized linked list for debugging
  * */
@@ -712,39 +959,106 @@ void print_debug(struct token *head) {
 }
 
 /*
- * Free memory kept by linked list
+ * Free memory kept by tokens of the current line
  * */
-void free_ll(struct token *head) {
-    if(head==NULL){
-        return;
-    }
-    struct token *iter = head;
-    struct token *freed;
-    while (iter->token_type != EOL) {
-        freed = iter;
-        iter = iter->next;
-        free(freed);
+void free_tokens() {
+    for (int i = 0; i < LINE_TOKEN_IDX; i++) {
+        free(LINE_TOKENS[i]);
     }
+    LINE_TOKEN_IDX = 0;
 }
 
 int main(int argc, char* argv[]) {
 
-    char in_name[64];
-    char out_name[64];
-    char* postfix;
-    //Extract file name
-    strcpy(in_name, argv[1]);
+    char *in_name = NULL;
+    char *out_name;
+    char *postfix;
+    char *trace_name = NULL;
+    int usage_error = 0;
+    //Parse options, the remaining argument is the input file
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--stats") == 0) {
+            STATS_ON = 1;
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            PROFILE_ON = 1;
+        } else if (strncmp(argv[i], "--trace-chunk=", 14) == 0) {
+            TRACE_CHUNK = atoi(argv[i] + 14);
+            if (TRACE_CHUNK < 1) {
+                usage_error = 1;
+            }
+        } else if (strncmp(argv[i], "--trace=", 8) == 0) {
+            trace_name = argv[i] + 8;
+        } else if (strncmp(argv[i], "--", 2) == 0 || in_name != NULL) { //Unknown option or second input file
+            usage_error = 1;
+        } else {
+            in_name = argv[i];
+        }
+    }
+    if (in_name == NULL || usage_error) {
+        printf("Usage: %s [--stats] [--trace=<file.json>] [--trace-chunk=<lines>] [--profile] <file.adv>\n", argv[0]);
+        return 1;
+    }
+    //Extract file name, extension is only searched after the last directory separator
     postfix = strrchr(in_name, '.');
-    strncpy(out_name, in_name, postfix - in_name);
-    strcat(out_name, ".ll");
+    if (postfix != NULL && strchr(postfix, '/') != NULL) {
+        postfix = NULL;
+    }
+    size_t base_length = (postfix != NULL)? (size_t) (postfix - in_name): strlen(in_name);
+    out_name = malloc(base_length + sizeof(".ll"));
+    snprintf(out_name, base_length + sizeof(".ll"), "%.*s.ll", (int) base_length, in_name);
+    if (strcmp(in_name, out_name) == 0) { //Output would overwrite the input
+        printf("Usage: %s [--stats] [--trace=<file.json>] [--trace-chunk=<lines>] [--profile] <file.adv>\n", argv[0]);
+        free(out_name);
+        return 1;
+    }
 
     FILE *fp;
-    fp = fopen("file.adv","r");
-    op = fopen("file.ll","w");
+    fp = fopen(in_name,"r");
+    if (fp == NULL) {
+        printf("Can not open %s!\n", in_name);
+        free(out_name);
+        return 1;
+    }
+    op = fopen(out_name,"w");
+    if (op == NULL) {
+        printf("Can not open %s!\n", out_name);
+        fclose(fp);
+        free(out_name);
+        return 1;
+    }
+    if (trace_name != NULL) {
+        TRACE_FP = fopen(trace_name, "w");
+        if (TRACE_FP == NULL) {
+            printf("Can not open %s!\n", trace_name);
+            fclose(fp);
+            fclose(op);
+            remove(out_name);
+            free(out_name);
+            return 1;
+        }
+        fprintf(TRACE_FP, "[\n");
+    }
+    START_TIME = now_ns();
+    long long start = phase_start();
     fprintf(op,"; ModuleID = 'advcalc2ir'\n");
     fprintf(op,"declare i32 @printf(i8*, ...)\n");
-    fprintf(op,"@print.str = constant [4 x i8] c\"%%d\\0A\\00\"\n\n");
+    fprintf(op,"@print.str = constant [4 x i8] c\"%%d\\0A\\00\"\n");
+    if (PROFILE_ON) { //Count lines the same way they are read below to size the cycle counter array
+        char line[256 + 1];
+        PROFILE_SLOTS = 1;
+        while (fgets(line, sizeof(line), fp)) {
+            PROFILE_SLOTS++;
+        }
+        rewind(fp);
+        profile_header();
+    }
+    fprintf(op,"\n");
     fprintf(op,"define i32 @main() {\n");
+    if (PROFILE_ON) {
+        fprintf(op,"\tcall void @profile.mark(i32 0)\n");
+        count_opcode("call");
+    }
+    phase_end(P_HEADER_CLOSE, start);
 
     int error_code = 0;
     int exit_code = 0;
@@ -760,25 +1074,47 @@ int main(int argc, char* argv[]) {
         struct token *head = NULL;
         struct token *tail = NULL;
         struct token *p_equal = NULL;
+        start = phase_start();
         error_code = lexer(p, strlen(p), &head, &tail, &p_equal);
+        phase_end(P_LEXER, start);
         if (error_code == 0) {
             if (p_equal != NULL) {
+                start = phase_start();
                 error_code = assign_syntax_checker(head, p_equal);
+                phase_end(P_SYNTAX, start);
+                if (error_code == 0 && VAR_IDX == VAR_LIMIT) { //Table is full, only existing variables can be assigned
+                    error_code = -1;
+                    for (int i = 0; i < VAR_IDX; i++) {
+                        if (strcmp(VAR_KEYS[i], head->token_val) == 0) {
+                            error_code = 0;
+                            break;
+                        }
+                    }
+                }
                 if (error_code == 0) {
+                    start = phase_start();
                     error_code = reformat_token_list(&p_equal);
+                    phase_end(P_REFORMAT, start);
                 }
             } else {
+                start = phase_start();
                 error_code = exp_syntax_checker(head);
+                phase_end(P_SYNTAX, start);
                 if (error_code == 0) {
+                    start = phase_start();
                     error_code = reformat_token_list(&head);
+                    phase_end(P_REFORMAT, start);
                 }
             }
             if (error_code == 0) {
                 if (head->token_type != EOL) {
+                    start = phase_start();
                     if (p_equal != NULL) {
 
                         calculate(p_equal->next);
                         char *var_name = calloc(256, sizeof(char));
+                        ALLOC_COUNT++;
+                        ALLOC_BYTES += 256;
                         strcpy(var_name, p_equal->prev->token_val);
 
                         int declared = 0;
@@ -786,11 +1122,14 @@ int main(int argc, char* argv[]) {
                             if (strcmp(VAR_KEYS[i], var_name) == 0) {
                                 VARS[i] = 1;
                                 declared = 1;
+                                free(var_name);
+                                var_name = VAR_KEYS[i];
                                 break;
                             }
                         }
                         if (declared == 0) {
                             fprintf(op,"\t%%%s = alloca i32\n", var_name);
+                            count_opcode("alloca");
                             VARS[VAR_IDX] = 1;
                             VAR_KEYS[VAR_IDX] = var_name;
                             VAR_IDX++;
@@ -798,29 +1137,53 @@ int main(int argc, char* argv[]) {
                         struct token *ptr = (p_equal->next->token_type == NOT)? p_equal->next->next: p_equal->next;
                         char *result = (strstr(ptr->register_name, "%reg"))? ptr->register_name: ptr->token_val;
                         fprintf(op,"\tstore i32 %s, i32* %%%s\n", result, var_name);
+                        count_opcode("store");
                     } else {
                         calculate(head);
                         struct token *ptr = (head->token_type == NOT)? head->next: head;
                         char *result = (strstr(ptr->register_name, "%reg"))? ptr->register_name: ptr->token_val;
                         fprintf(op,"\tcall i32 (i8*, ...) @printf(i8* getelementptr ([4 x i8], [4 x i8]* @print.str, i32 0, i32 0), i32 %s)\n", result);
+                        count_opcode("call");
                     }
+                    profile_mark();
+                    phase_end(P_CALCULATE, start);
                 }
             } else {
                 printf("Error on line %d!\n", LINE_IDX);
                 exit_code = 1;
             }
-            free_ll(head);
         } else {
             printf("Error on line %d!\n", LINE_IDX);
             exit_code = 1;
         }
+        free_tokens();
 
         LINE_IDX++;
+        if (TRACE_FP != NULL && (LINE_IDX - 1) % TRACE_CHUNK == 0) {
+            trace_flush();
+        }
     }
+    start = phase_start();
     if(exit_code==0) {
+        if (PROFILE_ON) {
+            fprintf(op, "\tcall void @profile.report()\n");
+        }
         fprintf(op, "\n\tret i32 0\n}");
     }
-    else{
+    fclose(fp);
+    fclose(op);
+    phase_end(P_HEADER_CLOSE, start);
+    if (exit_code != 0) {
         remove(out_name);
     }
+    free(out_name);
+    if (STATS_ON) {
+        print_stats();
+    }
+    if (TRACE_FP != NULL) {
+        trace_flush();
+        fprintf(TRACE_FP, "\n]\n");
+        fclose(TRACE_FP);
+    }
+    return exit_code;
 }